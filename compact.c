@@ -0,0 +1,90 @@
+/////////////////////////////////////
+// Paging Data Compaction Function //
+/////////////////////////////////////
+
+#include "general.h"
+#include "pager.h"
+#include "file_data.h"
+#include "compact.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Helper function: Converts a bit-mask of READ | WRITE | EXECUTE into a string of r, w, and x
+// characters. The buffer must have room for at least 4 characters.
+static const char* format_rwx(byte access, char* buf)
+{
+	char* s = buf;
+	if (access & READ) { *s++ = 'r'; }
+	if (access & WRITE) { *s++ = 'w'; }
+	if (access & EXECUTE) { *s++ = 'x'; }
+	*s = '\0';
+	return buf;
+}
+
+// Helper function: Writes out a memory reference line, only including the repeat count if needed.
+static void write_reference(FILE* out, uint64 pid, uint64 logical_addr, byte access, uint64 count)
+{
+	char rwx[4];
+	fprintf(out, "r %lu %lX %s", pid, logical_addr, format_rwx(access, rwx));
+	if (count > 1) { fprintf(out, " %lu", count); }
+	fprintf(out, "\n");
+}
+
+// Reads the paging data from in and writes it to out with every run of consecutive memory
+// references to the same page by the same process with the same access collapsed into a single
+// reference with a repeat count. Running the simulator on the compacted data gives exactly the
+// same output as on the original data. The number of memory references read and the number of
+// memory reference lines written are returned through refs and records. Returns false if the
+// paging data is invalid.
+bool compact_data(file_data* in, FILE* out, uint64* refs, uint64* records)
+{
+	*refs = *records = 0;
+
+	// Copy the basic information, the page size is needed to know which references are to the same page
+	uint64 log_mem_sz, phy_mem_sz, page_sz, num_procs;
+	if (!file_data_read_basic_info(in, &log_mem_sz, &phy_mem_sz, &page_sz, &num_procs)) { return false; }
+	fprintf(out, "%lu %lu %lu %lu\n", log_mem_sz, phy_mem_sz, page_sz, num_procs);
+
+	// The run of memory references currently being collapsed (if run_count is not 0)
+	uint64 run_pid = 0, run_addr = 0, run_count = 0;
+	byte run_access = 0;
+
+	while (true)
+	{
+		char type;
+		uint64 pid, val, val2;
+		byte access;
+		if (!file_data_read_data_line(in, &type, &pid, &val, &val2, &access))
+		{
+			// Either EOF reached or bad data
+			if (run_count) { write_reference(out, run_pid, run_addr, run_access, run_count); ++*records; }
+			return !file_data_get_last_line_read(in)[0];
+		}
+
+		if (type == 'r')
+		{
+			*refs += val2;
+
+			// Extend the current run if this is the same page with the same access
+			if (run_count && pid == run_pid && access == run_access && (val >> page_sz) == (run_addr >> page_sz))
+			{
+				run_count += val2;
+				continue;
+			}
+
+			// Otherwise start a new run
+			if (run_count) { write_reference(out, run_pid, run_addr, run_access, run_count); ++*records; }
+			run_pid = pid; run_addr = val; run_access = access; run_count = val2;
+			continue;
+		}
+
+		// Any other line ends the current run and is copied as-is
+		if (run_count) { write_reference(out, run_pid, run_addr, run_access, run_count); ++*records; }
+		run_count = 0;
+		char rwx[4];
+		if (type == 'a') { fprintf(out, "a %lu %lu %s\n", pid, val, format_rwx(access, rwx)); }
+		else if (type == 's') { fprintf(out, "s %lu %lu %lu\n", pid, val, val2); }
+		else { fprintf(out, "f %lu %lu\n", pid, val); }
+	}
+}
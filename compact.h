@@ -0,0 +1,22 @@
+/////////////////////////////////////
+// Paging Data Compaction Function //
+/////////////////////////////////////
+
+#ifndef _COMPACT_H_
+#define _COMPACT_H_
+
+#include "general.h"
+#include "file_data.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Reads the paging data from in and writes it to out with every run of consecutive memory
+// references to the same page by the same process with the same access collapsed into a single
+// reference with a repeat count. Running the simulator on the compacted data gives exactly the
+// same output as on the original data. The number of memory references read and the number of
+// memory reference lines written are returned through refs and records. Returns false if the
+// paging data is invalid.
+bool compact_data(file_data* in, FILE* out, uint64* refs, uint64* records);
+
+#endif
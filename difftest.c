@@ -0,0 +1,363 @@
+/////////////////////////////////////
+// Differential Testing of Pagers //
+/////////////////////////////////////
+
+// Compile: gcc -Wall difftest.c -o difftest
+//
+// Runs a reference build of the pager and an optimized build of the pager on randomly generated
+// paging data with every page replacement algorithm and checks that their outputs are identical.
+// Any paging data that makes them diverge is minimized and saved so it can be replayed by hand.
+// The time taken by each build is reported so the optimized build can also be measured.
+
+#include "general.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/wait.h>
+
+#define NUM_ALGORITHMS 3
+static const char* algorithms[NUM_ALGORITHMS] = { "FIFO", "SC", "LRU" };
+
+// Paging data being tested: the first line is the basic information followed by the data lines
+typedef struct _trace
+{
+	char** lines;
+	size_t num_lines, capacity;
+} trace;
+
+// Output of a single run of a pager
+typedef struct _run_output
+{
+	char* buf;
+	size_t len;
+	int status;
+} run_output;
+
+// Settings for generating the paging data
+static uint64 rng_state;
+static size_t trace_length = 2000;
+static bool basic_only = false;
+
+// Total time taken by each build for each algorithm
+static double engine_time[2][NUM_ALGORITHMS];
+
+// Helper function: Generates the next pseudo-random number (xorshift64*) in the range [0, n)
+static uint64 rng(uint64 n)
+{
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (rng_state * 2685821657736338717UL) % n;
+}
+
+// Helper function: Gets the current time in seconds
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Helper function: Appends a formatted line to the trace
+static void trace_add(trace* t, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static void trace_add(trace* t, const char* format, ...)
+{
+	if (t->num_lines == t->capacity)
+	{
+		t->capacity = t->capacity ? t->capacity * 2 : 256;
+		t->lines = (char**)realloc(t->lines, t->capacity*sizeof(char*));
+		if (!t->lines) { perror("failed to allocate memory"); exit(-1); }
+	}
+	char buf[128]; // generated lines are always short
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buf, sizeof(buf), format, args);
+	va_end(args);
+	t->lines[t->num_lines] = strdup(buf);
+	if (!t->lines[t->num_lines++]) { perror("failed to allocate memory"); exit(-1); }
+}
+
+// Helper function: Frees all memory used by the trace
+static void trace_free(trace* t)
+{
+	for (size_t i = 0; i < t->num_lines; ++i) { free(t->lines[i]); }
+	free(t->lines);
+	memset(t, 0, sizeof(trace));
+}
+
+// Helper function: Writes the lines of the trace that are not skipped to the given file
+static bool trace_write(const trace* t, const bool* skip, const char* filename)
+{
+	FILE* f = fopen(filename, "w");
+	if (!f) { return false; }
+	for (size_t i = 0; i < t->num_lines; ++i)
+	{
+		if (!skip || !skip[i]) { fprintf(f, "%s\n", t->lines[i]); }
+	}
+	return fclose(f) == 0;
+}
+
+// Generates random paging data. Most of the memory references are to allocated pages with the
+// allowed access, but some are not and they come in runs so that repeated references are tested.
+static void generate_trace(trace* t)
+{
+	static const char* rwx[] = { "r", "w", "x", "rw", "rx", "wx", "rwx" };
+	uint64 num_pages = 2 + rng(63), num_frames = 1 + rng(16), page_sz = 4 + rng(9), num_procs = 1 + rng(8);
+	trace_add(t, "%lu %lu %lu %lu", num_pages, num_frames, page_sz, num_procs);
+
+	for (size_t i = 0; i < trace_length; ++i)
+	{
+		uint64 pid = rng(num_procs), page = rng(num_pages), kind = rng(100);
+		if (kind < 15) { trace_add(t, "a %lu %lu %s", pid, page, rwx[rng(7)]); }
+		else if (!basic_only && kind < 17) { trace_add(t, "s %lu %lu %lu", pid, page, rng(num_procs)); }
+		else if (!basic_only && kind < 18) { trace_add(t, "f %lu %lu", pid, rng(num_procs)); }
+		else
+		{
+			// A run of references to the same page, possibly as a single counted reference
+			uint64 run = 1 + (rng(4) ? 0 : rng(8));
+			const char* access = rwx[rng(3)];
+			if (!basic_only && run > 1 && rng(2))
+			{
+				trace_add(t, "r %lu %lX %s %lu", pid, (page << page_sz) | rng(1UL << page_sz), access, run);
+				continue;
+			}
+			for (uint64 j = 0; j < run; ++j)
+			{
+				trace_add(t, "r %lu %lX %s", pid, (page << page_sz) | rng(1UL << page_sz), access);
+			}
+		}
+	}
+}
+
+// Runs the pager at the given path on the given file with the given algorithm, collecting everything
+// written to standard output. Standard error is ignored. The time taken is added to *elapsed.
+static void run_pager(const char* pager, const char* filename, const char* algorithm, run_output* out, double* elapsed)
+{
+	int fds[2];
+	if (pipe(fds)) { perror("failed to create pipe"); exit(-1); }
+	double start = now();
+	pid_t pid = fork();
+	if (pid < 0) { perror("failed to fork"); exit(-1); }
+	if (pid == 0)
+	{
+		// Child: run the pager with its output going to the pipe
+		int null_fd = open("/dev/null", O_WRONLY);
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		close(fds[0]); close(fds[1]); close(null_fd);
+		execl(pager, pager, filename, algorithm, (char*)NULL);
+		_exit(127);
+	}
+
+	// Parent: read all of the output
+	close(fds[1]);
+	size_t capacity = 0;
+	out->buf = NULL;
+	out->len = 0;
+	while (true)
+	{
+		if (out->len + 4096 > capacity)
+		{
+			capacity = capacity ? capacity * 2 : 65536;
+			out->buf = (char*)realloc(out->buf, capacity);
+			if (!out->buf) { perror("failed to allocate memory"); exit(-1); }
+		}
+		ssize_t n = read(fds[0], out->buf + out->len, capacity - out->len);
+		if (n <= 0) { break; }
+		out->len += n;
+	}
+	close(fds[0]);
+	waitpid(pid, &out->status, 0);
+	*elapsed += now() - start;
+}
+
+// Runs both pagers on the given file and checks if their outputs diverge. If timed then the time
+// taken by each one is recorded for the algorithm. If either pager could not be run or the
+// reference pager fails on the paging data then there is nothing to compare against, so the
+// program is stopped (keeping the paging data file around). If keep is given then the outputs of
+// both pagers are stored in it (and must be freed by the caller), otherwise they are freed.
+static bool diverges(const char* pagers[2], const char* filename, int algorithm, bool timed, run_output keep[2])
+{
+	run_output out[2];
+	double elapsed[2] = { 0, 0 };
+	for (int e = 0; e < 2; ++e)
+	{
+		run_pager(pagers[e], filename, algorithms[algorithm], &out[e], &elapsed[e]);
+		if (WIFEXITED(out[e].status) && WEXITSTATUS(out[e].status) == 127)
+		{
+			fprintf(stderr, "could not run %s\n", pagers[e]);
+			exit(2);
+		}
+	}
+	if (out[0].status != 0)
+	{
+		fprintf(stderr, "the reference pager failed with %s on %s (%s %d)\n", algorithms[algorithm], filename,
+		        WIFEXITED(out[0].status) ? "exit status" : "signal",
+		        WIFEXITED(out[0].status) ? WEXITSTATUS(out[0].status) : WTERMSIG(out[0].status));
+		exit(2);
+	}
+	if (timed) { for (int e = 0; e < 2; ++e) { engine_time[e][algorithm] += elapsed[e]; } }
+	bool differ = out[0].status != out[1].status || out[0].len != out[1].len || memcmp(out[0].buf, out[1].buf, out[0].len);
+	if (keep) { keep[0] = out[0]; keep[1] = out[1]; }
+	else { free(out[0].buf); free(out[1].buf); }
+	return differ;
+}
+
+// Helper function: prints the line of out starting at offset i (or a note if the output ended)
+static void print_output_line(const char* name, const run_output* out, size_t i)
+{
+	if (i >= out->len) { printf("  %s: <end of output>\n", name); return; }
+	size_t end = i;
+	while (end < out->len && out->buf[end] != '\n') { end++; }
+	printf("  %s: %.*s\n", name, (int)(end - i), out->buf + i);
+}
+
+// Prints the first line where the outputs of the two pagers differ, or their exit statuses if
+// the outputs themselves are the same
+static void print_first_difference(const run_output out[2])
+{
+	size_t i = 0, line_start = 0, line = 1;
+	while (i < out[0].len && i < out[1].len && out[0].buf[i] == out[1].buf[i])
+	{
+		if (out[0].buf[i++] == '\n') { line_start = i; line++; }
+	}
+	if (i == out[0].len && i == out[1].len)
+	{
+		printf("  Outputs match but the pagers end differently:\n");
+		for (int e = 0; e < 2; ++e)
+		{
+			printf("  %s: %s %d\n", e ? "optimized" : "reference", WIFEXITED(out[e].status) ? "exit status" : "signal",
+			       WIFEXITED(out[e].status) ? WEXITSTATUS(out[e].status) : WTERMSIG(out[e].status));
+		}
+		return;
+	}
+	printf("  First difference on output line %zu:\n", line);
+	print_output_line("reference", &out[0], line_start);
+	print_output_line("optimized", &out[1], line_start);
+}
+
+// Minimizes the paging data that makes the pagers diverge by repeatedly removing chunks of data
+// lines (never the basic information) as long as the pagers still diverge, halving the chunk size
+// each time no chunk can be removed. On return skip marks every line that was removed.
+static void minimize_trace(const char* pagers[2], const trace* t, bool* skip, const char* filename, int algorithm)
+{
+	size_t chunk = (t->num_lines - 1) / 2;
+	while (chunk >= 1)
+	{
+		bool removed = false;
+		for (size_t start = 1; start < t->num_lines; start += chunk)
+		{
+			// Try to remove the lines in the chunk that are still present
+			size_t end = start + chunk < t->num_lines ? start + chunk : t->num_lines;
+			bool* try_skip = (bool*)malloc(t->num_lines*sizeof(bool));
+			if (!try_skip) { perror("failed to allocate memory"); exit(-1); }
+			memcpy(try_skip, skip, t->num_lines*sizeof(bool));
+			bool any = false;
+			for (size_t i = start; i < end; ++i) { any |= !try_skip[i]; try_skip[i] = true; }
+			if (any && trace_write(t, try_skip, filename) && diverges(pagers, filename, algorithm, false, NULL))
+			{
+				memcpy(skip, try_skip, t->num_lines*sizeof(bool));
+				removed = true;
+			}
+			free(try_skip);
+		}
+		if (!removed) { chunk /= 2; }
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Parse the options
+	uint64 num_traces = 100, seed = 1;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:l:b")) != -1)
+	{
+		if      (opt == 'n') { num_traces = strtoul(optarg, NULL, 10); }
+		else if (opt == 's') { seed = strtoul(optarg, NULL, 10); }
+		else if (opt == 'l') { trace_length = strtoul(optarg, NULL, 10); }
+		else if (opt == 'b') { basic_only = true; }
+		else { optind = argc + 1; break; }
+	}
+	if (argc - optind != 2)
+	{
+		printf("usage: %s [-n num_traces] [-s seed] [-l trace_length] [-b] reference_pager optimized_pager\n", argv[0]);
+		printf("  -b only generates page allocations and memory references without repeat counts\n");
+		return argc == 1 ? 0 : 1;
+	}
+	const char* pagers[2] = { argv[optind], argv[optind+1] };
+	for (int e = 0; e < 2; ++e)
+	{
+		if (access(pagers[e], X_OK)) { fprintf(stderr, "%s is not an executable pager\n", pagers[e]); return 2; }
+	}
+
+	// Temporary file for the paging data
+	char filename[] = "/tmp/difftest-XXXXXX";
+	int tmp_fd = mkstemp(filename);
+	if (tmp_fd < 0) { perror("failed to create temporary file"); return 1; }
+	close(tmp_fd);
+
+	// Run every trace with every algorithm
+	uint64 failures = 0;
+	for (uint64 n = 0; n < num_traces; ++n)
+	{
+		// Each trace is seeded on its own so a failure can be reproduced with -s and -n 1
+		trace t = { NULL, 0, 0 };
+		rng_state = (seed + n) * 0x9E3779B97F4A7C15UL + 1;
+		generate_trace(&t);
+		if (!trace_write(&t, NULL, filename)) { perror("failed to write paging data"); return 1; }
+
+		for (int a = 0; a < NUM_ALGORITHMS; ++a)
+		{
+			if (!diverges(pagers, filename, a, true, NULL)) { continue; }
+
+			// Shrink the paging data down and save it
+			failures++;
+			bool* skip = (bool*)calloc(t.num_lines, sizeof(bool));
+			if (!skip) { perror("failed to allocate memory"); return 1; }
+			minimize_trace(pagers, &t, skip, filename, a);
+			char failname[64];
+			snprintf(failname, sizeof(failname), "difftest-%lu-%s.txt", seed + n, algorithms[a]);
+			trace_write(&t, skip, failname);
+			size_t kept = 0;
+			for (size_t i = 0; i < t.num_lines; ++i) { kept += !skip[i]; }
+			printf("Seed %lu diverges with %s, minimized from %zu to %zu lines in %s\n",
+			       seed + n, algorithms[a], t.num_lines, kept, failname);
+
+			// Show where the outputs of the minimized paging data differ
+			run_output out[2];
+			trace_write(&t, skip, filename);
+			diverges(pagers, filename, a, false, out);
+			print_first_difference(out);
+			free(out[0].buf);
+			free(out[1].buf);
+			free(skip);
+
+			// Restore the full paging data for the remaining algorithms
+			trace_write(&t, NULL, filename);
+		}
+		trace_free(&t);
+	}
+	unlink(filename);
+
+	// Print out the timing summary
+	printf("----------------------------------------\n");
+	printf("%-10s", "Engine");
+	for (int a = 0; a < NUM_ALGORITHMS; ++a) { printf(" %10s", algorithms[a]); }
+	printf(" %10s\n", "Total");
+	for (int e = 0; e < 2; ++e)
+	{
+		double total = 0;
+		printf("%-10s", e ? "Optimized" : "Reference");
+		for (int a = 0; a < NUM_ALGORITHMS; ++a) { printf(" %9.3fs", engine_time[e][a]); total += engine_time[e][a]; }
+		printf(" %9.3fs\n", total);
+	}
+	printf("Traces: %lu, Divergences: %lu\n", num_traces, failures);
+	return failures ? 1 : 0;
+}
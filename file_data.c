@@ -120,11 +120,14 @@ byte convert_rwx(const char* s)
     return mask;
 }
 
-// Read a line of data from the paging data file which is either a page allocation or a memory
-// reference. The arguments are filled in with the type ('a' or 'r'), the PID of the process,
-// the associated value (either a page number for type == 'a' or a logical address for type == 'r'),
-// and the access being allowed/requestd. Returns false for an invalid line and true otherwise.
-bool file_data_read_data_line(file_data* fd, char* type, uint64* pid, uint64* val, byte* access)
+// Read a line of data from the paging data file which is either a page allocation, a memory
+// reference, a page share, or a fork. The arguments are filled in with the type ('a', 'r', 's', or
+// 'f'), the PID of the process, the associated value (a page number for type == 'a' or 's', a
+// logical address for type == 'r', or the PID of the child for type == 'f'), the second value (the
+// PID of the process whose page is being shared for type == 's', the number of times the reference
+// is repeated for type == 'r', 0 otherwise), and the access being allowed/requestd (0 for type ==
+// 's' or 'f'). Returns false for an invalid line and true otherwise.
+bool file_data_read_data_line(file_data* fd, char* type, uint64* pid, uint64* val, uint64* val2, byte* access)
 {
     // Get the next line of data
     char* s;
@@ -135,10 +138,31 @@ bool file_data_read_data_line(file_data* fd, char* type, uint64* pid, uint64* va
     } while (!s[0]); // skip blank lines
     *type = s[0];
 
-	// Parse the data line
+	// Parse a page share or fork line of data, neither of which have any access
     char dummy = 0, _access[4] = {0, 0, 0, 0};
-    int count = (s[0] == 'a') ? sscanf(s, "a %lu %lu %3s %c", pid, val, _access, &dummy) : // parse a memory allocation line of data
-                ((s[0] == 'r') ? sscanf(s, "r %lu %lx %c %c", pid, val, _access, &dummy) : 0); // parse a memory reference line of data
+    *val2 = *access = 0;
+    if (s[0] == 's') { return sscanf(s, "s %lu %lu %lu %c", pid, val, val2, &dummy) == 3 && !dummy; }
+    if (s[0] == 'f') { return sscanf(s, "f %lu %lu %c", pid, val, &dummy) == 2 && !dummy; }
+
+	// Parse a memory reference line of data, which may be followed by a repeat count (in compacted
+	// paging data files)
+    if (s[0] == 'r')
+    {
+        int n = 0;
+        *val2 = 1;
+        if (sscanf(s, "r %lu %lx %c%n", pid, val, _access, &n) != 3) { return false; }
+        const char* rest = s + n;
+        if (!rest[0]) { return (*access = convert_rwx(_access)); }
+
+        // The repeat count must be a positive base-10 integer (%lu would also accept a sign)
+        if (!isspace(rest[0])) { return false; }
+        while (isspace(*rest)) { rest++; }
+        if (!isdigit(rest[0]) || sscanf(rest, "%lu %c", val2, &dummy) != 1 || !*val2) { return false; }
+        return (*access = convert_rwx(_access));
+    }
+
+	// Parse a memory allocation line of data
+    int count = (s[0] == 'a') ? sscanf(s, "a %lu %lu %3s %c", pid, val, _access, &dummy) : 0;
     // Check that the data was parsed correctly and convert the rwx flags
     return count == 3 && !dummy && (*access = convert_rwx(_access));
 }
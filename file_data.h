@@ -22,11 +22,14 @@ void file_data_close(file_data* fd);
 // read values.
 bool file_data_read_basic_info(file_data* fd, uint64* log_mem_sz, uint64* phy_mem_sz, uint64* page_sz, uint64* num_procs);
 
-// Read a line of data from the paging data file which is either a page allocation or a memory
-// reference. The arguments are filled in with the type ('a' or 'r'), the PID of the process,
-// the associated value (either a page number for type == 'a' or a logical address for type == 'r'),
-// and the access being allowed/requestd. Returns false for an invalid line and true otherwise.
-bool file_data_read_data_line(file_data* fd, char* type, uint64* pid, uint64* val, byte* access);
+// Read a line of data from the paging data file which is either a page allocation, a memory
+// reference, a page share, or a fork. The arguments are filled in with the type ('a', 'r', 's', or
+// 'f'), the PID of the process, the associated value (a page number for type == 'a' or 's', a
+// logical address for type == 'r', or the PID of the child for type == 'f'), the second value (the
+// PID of the process whose page is being shared for type == 's', the number of times the reference
+// is repeated for type == 'r', 0 otherwise), and the access being allowed/requestd (0 for type ==
+// 's' or 'f'). Returns false for an invalid line and true otherwise.
+bool file_data_read_data_line(file_data* fd, char* type, uint64* pid, uint64* val, uint64* val2, byte* access);
 
 // Gets the last line read by either file_data_read_basic_info or file_data_read_data_line
 const char* file_data_get_last_line_read(file_data* fd);
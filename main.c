@@ -2,7 +2,7 @@
 // Main Function //
 ///////////////////
 
-// Compile: gcc -Wall main.c pager.c fifo.c sc.c lru.c file_data.c -o pager
+// Compile: gcc -Wall main.c pager.c fifo.c sc.c lru.c file_data.c compact.c -o pager
 
 #include "general.h"
 #include "pager.h"
@@ -10,25 +10,58 @@
 #include "sc.h"
 #include "lru.h"
 #include "file_data.h"
+#include "compact.h"
 
+#include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// Parse a base-10 unsigned integer argument, returning false if it is not one
+static bool parse_uint(const char* s, uint64* val)
+{
+    // strtoul would skip leading whitespace and accept a sign, so the first character must be a digit
+    if (!isdigit((unsigned char)s[0])) { return false; }
+    char* end;
+    errno = 0;
+    *val = strtoul(s, &end, 10);
+    return !*end && errno != ERANGE;
+}
+
 int main(int argc, const char** argv)
 {
 	// Basic argument checks
     if (argc == 1)
     {
-        printf("usage: %s input_file [FIFO|SC|LRU]\n", argv[0]);
+        printf("usage: %s input_file [FIFO|SC|LRU|COMPACT] [compressed_pool_pages [dram_ns compressed_ns swap_ns]]\n", argv[0]);
         return 0;
     }
 
-    if (argc != 3)
+    if (argc != 3 && argc != 4 && argc != 7)
     {
-        fprintf(stderr, "wrong number of arguments (expected 2, got %d)\n", argc-1);
+        fprintf(stderr, "wrong number of arguments (expected 2, 3, or 6, got %d)\n", argc-1);
         return 1;
     }
 
+    // Size of the compressed pool (in pages), if there is one, and the modelled latencies of memory
+    // and each tier
+    uint64 pool_sz = 0;
+    uint64 latencies[3] = { DEFAULT_DRAM_LATENCY, DEFAULT_COMPRESSED_LATENCY, DEFAULT_SWAP_LATENCY };
+    if (argc >= 4 && !parse_uint(argv[3], &pool_sz))
+    {
+        fprintf(stderr, "%s is not a valid compressed pool size\n", argv[3]);
+        return 1;
+    }
+    for (int i = 4; i < argc; ++i)
+    {
+        if (!parse_uint(argv[i], &latencies[i-4]))
+        {
+            fprintf(stderr, "%s is not a valid latency\n", argv[i]);
+            return 1;
+        }
+    }
+
     // Open the data file
     file_data* fd = file_data_open(argv[1]);
     if (!fd)
@@ -37,6 +70,27 @@ int main(int argc, const char** argv)
         return 1;
     }
 
+    // Write out the compacted paging data instead of running the simulation
+    if (!strcmp(argv[2], "COMPACT"))
+    {
+        if (argc != 3)
+        {
+            fprintf(stderr, "wrong number of arguments for COMPACT (expected 2, got %d)\n", argc-1);
+            file_data_close(fd);
+            return 1;
+        }
+        uint64 refs, records;
+        bool ok = compact_data(fd, stdout, &refs, &records);
+        if (!ok) { fprintf(stderr, "invalid data: %s\n", file_data_get_last_line_read(fd)); }
+        else
+        {
+            fprintf(stderr, "compacted %lu memory references into %lu lines (ratio %.2f)\n",
+                    refs, records, records ? (double) refs / records : 0.0);
+        }
+        file_data_close(fd);
+        return ok ? 0 : 1;
+    }
+
     // Setup which page replacement algorithm we will be using
     f_select_victim_frame select_victim_frame;
     if      (!strcmp(argv[2], "FIFO")) { select_victim_frame = fifo_select_victim_frame; }
@@ -59,22 +113,23 @@ int main(int argc, const char** argv)
     }
 
     // Initialize the pager
-    void* pager = pager_data_init(log_mem_sz, phy_mem_sz, page_sz, num_procs);
+    void* pager = pager_data_init(log_mem_sz, phy_mem_sz, page_sz, num_procs, pool_sz);
     if (!pager)
     {
         fprintf(stderr, "unable to initlize the pager\n");
         file_data_close(fd);
         return 1;
     }
+    set_tier_latencies(pager, latencies[0], latencies[1], latencies[2]);
 
     // Loop through all lines in the paging data file
     while (true)
     {
         char type;
-        uint64 pid, val;
+        uint64 pid, val, val2;
         byte access;
         // Read data line
-        if (!file_data_read_data_line(fd, &type, &pid, &val, &access))
+        if (!file_data_read_data_line(fd, &type, &pid, &val, &val2, &access))
         {
             const char *s = file_data_get_last_line_read(fd);
             if (!s[0]) { break; } // EOF reached
@@ -87,6 +142,10 @@ int main(int argc, const char** argv)
         }
         // Run page allocation (val is the page number)
         if (type == 'a') { alloc_page(pager, pid, val, access); }
+        // Share a page of another process (val is the page number, val2 is the other process)
+        else if (type == 's') { share_page(pager, pid, val, val2); }
+        // Fork a process (val is the child process)
+        else if (type == 'f') { fork_process(pager, pid, val); }
         else
 		{
 			// Run memory reference (val is the logical address)
@@ -97,6 +156,13 @@ int main(int argc, const char** argv)
 				uint64 f = select_victim_frame(pager);
 				claim_frame(pager, pid, val, f);
 			}
+
+			// Repeated memory reference (val2 is the repeat count), all but the first are hits
+			if (val2 > 1)
+			{
+				if (status != INVALID_PAGE) { repeat_reference(pager, pid, val, access, val2 - 1); }
+				else { for (uint64 i = 1; i < val2; ++i) { check_log_addr(pager, pid, val, access); } }
+			}
 		}
     }
 
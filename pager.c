@@ -9,69 +9,129 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <sys/mman.h>
+
+// Configurations whose arena is at least this large are allocated directly with mmap so that the
+// kernel hands out lazily zeroed pages (and huge pages when it can) instead of going through malloc.
+#define ARENA_MMAP_THRESHOLD (2UL << 20)
+
+// Round n up to a multiple of align (which must be a power of 2)
+#define ALIGN_UP(n, align) (((n) + (align) - 1) & ~((uint64)(align) - 1))
+
+// Helper function: set *sum to a + b rounded up to a multiple of align (which must be a power of
+// 2), returns false if that does not fit in a uint64
+static bool arena_add(uint64 a, uint64 b, uint64 align, uint64* sum)
+{
+	if (a > (uint64) -1 - b || a + b > (uint64) -1 - (align - 1)) { return false; }
+	*sum = ALIGN_UP(a + b, align);
+	return true;
+}
+
+// Allocate a zeroed block of sz bytes for the pager arena. Large blocks are mapped anonymously and
+// are backed by transparent huge pages if possible, small blocks come from calloc. Sets *mapped
+// accordingly.
+static void* arena_alloc(uint64 sz, bool* mapped)
+{
+	if (sz < ARENA_MMAP_THRESHOLD)
+	{
+		*mapped = false;
+		return calloc(1, sz);
+	}
+
+	// Anonymous mappings are already zeroed and their pages are only touched on first use. Explicit
+	// huge pages (MAP_HUGETLB) are not used since they would be reserved up front and the mapping
+	// length would depend on the system's huge page size.
+	*mapped = true;
+	void* arena = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (arena == MAP_FAILED) { return NULL; }
+#ifdef MADV_HUGEPAGE
+	madvise(arena, sz, MADV_HUGEPAGE);
+#endif
+	return arena;
+}
 
 // Initialize the pager with the given logical memory size (in number of pages), the physical
 // memory size (in number of frames), the size of an individual page/frame (in bits), and the
-// maximum number of processes on the system.
-pager_data* pager_data_init(uint64 log_mem_sz, uint64 phy_mem_sz, uint64 page_sz, uint64 num_procs)
+// maximum number of processes on the system, and the size of the compressed pool (in number of
+// pages, 0 to write modified pages directly to the swap space).
+//
+// The pager, its frames, and all of the page tables are carved out of a single zeroed arena so
+// that setting up and tearing down the pager is a single allocation no matter the number of
+// processes.
+pager_data* pager_data_init(uint64 log_mem_sz, uint64 phy_mem_sz, uint64 page_sz, uint64 num_procs, uint64 pool_sz)
 {
-	pager_data* pager = malloc(sizeof(pager_data));
-	if (!pager) { return NULL; }
-	memset(pager, 0, sizeof(pager_data));
-	
+	// Make sure the individual sizes do not overflow
+	if (num_procs && log_mem_sz > (uint64) -1 / sizeof(uint64) / num_procs) { return NULL; }
+	if (phy_mem_sz > (uint64) -1 / sizeof(frame)) { return NULL; }
+	uint64 tables_sz = num_procs*log_mem_sz*sizeof(page_table_entry);
+	uint64 rmap_sz = num_procs*log_mem_sz*sizeof(uint64);
+	uint64 pool_links_sz = pool_sz ? rmap_sz : 0;
+
+	// Layout of the arena: the pager itself, then the frames, then the page tables, then the two
+	// reverse-map link arrays, then the two compressed pool link arrays (only if there is a pool).
+	// The reverse-map is only written for shared pages and the pool links only for pages in the
+	// pool. In a mapped arena the kernel only backs the parts that are written (in huge page sized
+	// pieces when transparent huge pages are used), so the untouched parts of the links take little
+	// real memory. Every step is checked so that the offsets cannot wrap around.
+	uint64 frames_off, tables_off, rmap_next_off, rmap_prev_off, pool_next_off, pool_prev_off, arena_sz;
+	if (!arena_add(sizeof(pager_data), 0, sizeof(uint64), &frames_off) ||
+	    !arena_add(frames_off, phy_mem_sz*sizeof(frame), sizeof(uint64), &tables_off) ||
+	    !arena_add(tables_off, tables_sz, sizeof(uint64), &rmap_next_off) ||
+	    !arena_add(rmap_next_off, rmap_sz, sizeof(uint64), &rmap_prev_off) ||
+	    !arena_add(rmap_prev_off, rmap_sz, sizeof(uint64), &pool_next_off) ||
+	    !arena_add(pool_next_off, pool_links_sz, sizeof(uint64), &pool_prev_off) ||
+	    !arena_add(pool_prev_off, pool_links_sz, sizeof(uint64), &arena_sz)) { return NULL; }
+
+	// Allocate the arena (everything is initialized to all-0)
+	bool mapped;
+	byte* arena = arena_alloc(arena_sz, &mapped);
+	if (!arena) { return NULL; }
+	pager_data* pager = (pager_data*)arena;
+	pager->arena_sz = arena_sz;
+	pager->arena_mapped = mapped;
+	pager->frames = (frame*)(arena + frames_off);
+	pager->page_tables = (page_table_entry*)(arena + tables_off);
+	pager->rmap_next = (uint64*)(arena + rmap_next_off);
+	pager->rmap_prev = (uint64*)(arena + rmap_prev_off);
+	pager->pool_next = pool_sz ? (uint64*)(arena + pool_next_off) : NULL;
+	pager->pool_prev = pool_sz ? (uint64*)(arena + pool_prev_off) : NULL;
+
 	// Basic settings
 	pager->FIFO_victim = -1;
 	pager->SC_head_frame = 0;
 	pager->memory_reference_count = pager->pf_total = 0;
-	pager->pf_discarded_frames = pager->pf_written_frames = 0;
+	pager->pf_discarded_frames = pager->pf_written_frames = pager->pf_cow_copies = 0;
 	pager->num_pages = log_mem_sz;
 	pager->num_frames = pager->num_free_frames = phy_mem_sz;
 	pager->page_sz = page_sz;
 	pager->num_procs = num_procs;
-	
-	// Allocate the frames array
-	pager->frames = malloc(phy_mem_sz*sizeof(frame));
-	if (!pager->frames) { pager_data_dealloc(pager); return NULL; }
-	memset(pager->frames, 0, phy_mem_sz*sizeof(frame));
-	
-	// Allocate the page_tables array
-	pager->page_tables = malloc(num_procs*sizeof(page_table_entry*));
-	if (!pager->page_tables) { pager_data_dealloc(pager); return NULL; }
-	memset(pager->page_tables, 0, num_procs*sizeof(page_table_entry*));
-	
-	// Allocate each page table (all entries initialized to all-0)
-	for (int i = 0; i < pager->num_procs; ++i)
-	{
-		pager->page_tables[i] = malloc(log_mem_sz*sizeof(page_table_entry));
-		if (!pager->page_tables[i]) { pager_data_dealloc(pager); return NULL; }
-		memset(pager->page_tables[i], 0, log_mem_sz*sizeof(page_table_entry));
-	}
+	pager->pool_head = pager->pool_tail = EMPTY;
+	pager->pool_count = 0;
+	pager->pool_sz = pool_sz;
+	set_tier_latencies(pager, DEFAULT_DRAM_LATENCY, DEFAULT_COMPRESSED_LATENCY, DEFAULT_SWAP_LATENCY);
 
     return pager;
 }
 
+// Set the modelled latency (in nanoseconds) of a memory reference served from memory, from the
+// compressed pool, and from the swap space or backing store. These are only used for the summary.
+void set_tier_latencies(pager_data* pager, uint64 dram, uint64 compressed, uint64 swap)
+{
+	pager->dram_latency = dram;
+	pager->tier_latency[TIER_NONE] = swap;
+	pager->tier_latency[TIER_COMPRESSED] = compressed;
+	pager->tier_latency[TIER_SWAP] = swap;
+}
+
 // Deallocate any memory that was allocated for the pager (including the pager itself). After
 // this is called the pager can no longer be used.
 void pager_data_dealloc(pager_data* pager)
 {
 	if (pager)
 	{
-		// Free frames array
-		free(pager->frames);
-		
-		if (pager->page_tables)
-		{
-			// Free each page table
-			for (int i = 0; i < pager->num_procs; ++i)
-			{
-				free(pager->page_tables[i]);
-			}
-			
-			// Free page_tables array
-			free(pager->page_tables);
-		}
-		
-		free(pager);
+		// Everything lives in the arena so there is only a single block to release
+		if (pager->arena_mapped) { munmap(pager, pager->arena_sz); }
+		else { free(pager); }
 	}
 }
 
@@ -87,14 +147,211 @@ void alloc_page(pager_data* pager, uint64 pid, uint64 p, byte access)
 	if (pid >= pager->num_procs) { fprintf(stderr, "Invalid PID: %lu\n", pid); return; }
 	if (p >= pager->num_pages) { fprintf(stderr, "Invalid page: %lu\n", p); return; }
 
-	// Set the flags in the page table entry (including the flag for allocation)
-	pager->page_tables[pid][p].flags = access | ALLOCATED;
+	// Set the flags in the page table entry (including the flag for allocation). A page that is also
+	// mapped by other processes only has its access updated since the rest of its flags are kept in
+	// sync with the other mappings.
+	page_table_entry* entry = get_page_table_entry(pager, pid, p);
+	if (!is_page_shared(pager, entry)) { entry->flags = access | ALLOCATED; return; }
+	entry->flags = (entry->flags & ~(READ | WRITE | EXECUTE)) | access;
+
+	// A page that was forked read-only becomes copy-on-write once it can be written so that the write
+	// does not end up in the pages of the other processes
+	if ((access & WRITE) && !(entry->flags & SHARED))
+	{
+		uint64 idx = entry - pager->page_tables;
+		for (uint64 i = idx;;)
+		{
+			pager->page_tables[i].flags |= COPY_ON_WRITE;
+			if ((i = pager->rmap_next[i] - 1) == idx) { break; }
+		}
+	}
+}
+
+// Helper function: Adds the page table entry at index idx to the reverse-map list of the entry at
+// index src. The page table entry takes on the frame and residency of the source entry.
+static void rmap_link(pager_data* pager, uint64 idx, uint64 src)
+{
+	// A private page becomes a list of one before anything is linked to it
+	if (!pager->rmap_next[src]) { pager->rmap_next[src] = pager->rmap_prev[src] = src + 1; }
+
+	// Insert right after the source entry
+	uint64 next = pager->rmap_next[src] - 1;
+	pager->rmap_next[idx] = next + 1;
+	pager->rmap_prev[idx] = src + 1;
+	pager->rmap_prev[next] = idx + 1;
+	pager->rmap_next[src] = idx + 1;
+
+	// Same frame and residency as the source
+	page_table_entry* entry = &pager->page_tables[idx];
+	page_table_entry* src_entry = &pager->page_tables[src];
+	entry->frame = src_entry->frame;
+	entry->tier = src_entry->tier;
+	entry->flags |= src_entry->flags & VALID;
+}
+
+// Helper function: Checks if the page table entry at index idx is in the compressed pool queue
+static inline bool pool_contains(pager_data* pager, uint64 idx)
+{
+	return pager->pool_sz && (pager->pool_head == idx || pager->pool_prev[idx]);
+}
+
+// Helper function: Adds the page table entry at index idx to the end of the compressed pool queue
+static void pool_append(pager_data* pager, uint64 idx)
+{
+	pager->pool_next[idx] = 0;
+	pager->pool_prev[idx] = (pager->pool_tail == EMPTY) ? 0 : pager->pool_tail + 1;
+	if (pager->pool_tail == EMPTY) { pager->pool_head = idx; }
+	else { pager->pool_next[pager->pool_tail] = idx + 1; }
+	pager->pool_tail = idx;
+	pager->pool_count++;
+}
+
+// Helper function: Removes the page table entry at index idx from the compressed pool queue
+static void pool_remove(pager_data* pager, uint64 idx)
+{
+	uint64 next = pager->pool_next[idx], prev = pager->pool_prev[idx];
+	if (prev) { pager->pool_next[prev - 1] = next; } else { pager->pool_head = next ? next - 1 : EMPTY; }
+	if (next) { pager->pool_prev[next - 1] = prev; } else { pager->pool_tail = prev ? prev - 1 : EMPTY; }
+	pager->pool_next[idx] = pager->pool_prev[idx] = 0;
+	pager->pool_count--;
+}
+
+// Helper function: Finds the page table entry that represents the page of the entry at index idx
+// in the compressed pool queue, which may be any of the entries mapping the page if it is shared.
+// Returns EMPTY if the page is not in the queue.
+static uint64 pool_find(pager_data* pager, uint64 idx)
+{
+	if (pool_contains(pager, idx)) { return idx; }
+	if (pager->rmap_next[idx])
+	{
+		for (uint64 i = pager->rmap_next[idx] - 1; i != idx; i = pager->rmap_next[i] - 1)
+		{
+			if (pool_contains(pager, i)) { return i; }
+		}
+	}
+	return EMPTY;
+}
+
+// Helper function: Sets the tier of the page table entry at index idx along with every other
+// mapping of the same page.
+static void set_tier(pager_data* pager, uint64 idx, uint64 tier)
+{
+	pager->page_tables[idx].tier = tier;
+	if (pager->rmap_next[idx])
+	{
+		for (uint64 i = pager->rmap_next[idx] - 1; i != idx; i = pager->rmap_next[i] - 1)
+		{
+			pager->page_tables[i].tier = tier;
+		}
+	}
+}
+
+// Helper function: Removes the page table entry at index idx from its reverse-map list, making it a
+// private page again. If only a single entry is left in the list it becomes private as well. If the
+// entry was representing a resident page in its frame then the next entry takes over.
+static void rmap_unlink(pager_data* pager, uint64 idx)
+{
+	uint64 next = pager->rmap_next[idx] - 1, prev = pager->rmap_prev[idx] - 1;
+
+	// The copy in the compressed pool still belongs to the other entries so hand it over
+	if (pool_contains(pager, idx))
+	{
+		uint64 pool_next = pager->pool_next[idx], pool_prev = pager->pool_prev[idx];
+		pager->pool_next[next] = pool_next;
+		pager->pool_prev[next] = pool_prev;
+		if (pool_prev) { pager->pool_next[pool_prev - 1] = next + 1; } else { pager->pool_head = next; }
+		if (pool_next) { pager->pool_prev[pool_next - 1] = next + 1; } else { pager->pool_tail = next; }
+		pager->pool_next[idx] = pager->pool_prev[idx] = 0;
+	}
+
+	pager->rmap_next[prev] = next + 1;
+	pager->rmap_prev[next] = prev + 1;
+	pager->rmap_next[idx] = pager->rmap_prev[idx] = 0;
+
+	// Hand over the frame to the next entry if needed, along with whether the page in it has been
+	// referenced or modified through this entry so that is not lost
+	page_table_entry* entry = &pager->page_tables[idx];
+	if (entry->flags & VALID)
+	{
+		pager->page_tables[next].flags |= entry->flags & (REFERENCED | DIRTY);
+		frame* frm = &pager->frames[entry->frame];
+		if (frm->pid*pager->num_pages + frm->page_number == idx)
+		{
+			frm->pid = next / pager->num_pages;
+			frm->page_number = next % pager->num_pages;
+		}
+	}
+
+	// The last one left is no longer shared with anyone
+	if (next == prev)
+	{
+		pager->rmap_next[next] = pager->rmap_prev[next] = 0;
+		pager->page_tables[next].flags &= ~COPY_ON_WRITE;
+	}
+}
+
+// A request for process pid to map page p of process src_pid at the same page number is being made.
+// Both processes see the same page from then on: it is paged in and out for all of them at once and
+// writes from either process are visible to the other. The page of pid must not be allocated yet
+// and the page of src_pid must not be mapped by a fork (those are copy-on-write, not shared). This
+// function does not bring a page into memory and does not print anything out.
+void share_page(pager_data* pager, uint64 pid, uint64 p, uint64 src_pid)
+{
+	// Argument checking
+	if (pid >= pager->num_procs) { fprintf(stderr, "Invalid PID: %lu\n", pid); return; }
+	if (src_pid >= pager->num_procs) { fprintf(stderr, "Invalid PID: %lu\n", src_pid); return; }
+	if (p >= pager->num_pages) { fprintf(stderr, "Invalid page: %lu\n", p); return; }
+	page_table_entry* entry = get_page_table_entry(pager, pid, p);
+	page_table_entry* src_entry = get_page_table_entry(pager, src_pid, p);
+	if (!(src_entry->flags & ALLOCATED)) { fprintf(stderr, "Page %lu of process %lu is not allocated\n", p, src_pid); return; }
+	if (entry->flags & ALLOCATED) { fprintf(stderr, "Page %lu of process %lu is already allocated\n", p, pid); return; }
+	if (is_page_shared(pager, src_entry) && !(src_entry->flags & SHARED))
+	{
+		fprintf(stderr, "Page %lu of process %lu is mapped by a fork and cannot be shared\n", p, src_pid);
+		return;
+	}
+
+	// The source is either private or already explicitly shared so only it and the new mapping need
+	// to be marked as shared
+	uint64 idx = pid*pager->num_pages + p, src = src_pid*pager->num_pages + p;
+	entry->flags = (src_entry->flags & (READ | WRITE | EXECUTE)) | ALLOCATED | SHARED;
+	src_entry->flags |= SHARED;
+	rmap_link(pager, idx, src);
+}
+
+// A request for process parent to fork into process child is being made. Every page allocated for
+// the parent is mapped into the child. Writable pages are marked copy-on-write in both processes
+// so the first write from either side gets a private copy. The child must not have any pages
+// allocated yet. This function does not bring a page into memory and does not print anything out.
+void fork_process(pager_data* pager, uint64 parent, uint64 child)
+{
+	// Argument checking
+	if (parent >= pager->num_procs) { fprintf(stderr, "Invalid PID: %lu\n", parent); return; }
+	if (child >= pager->num_procs || child == parent) { fprintf(stderr, "Invalid PID: %lu\n", child); return; }
+	page_table_entry* child_table = get_page_table_entry(pager, child, 0);
+	for (uint64 p = 0; p < pager->num_pages; ++p)
+	{
+		if (child_table[p].flags & ALLOCATED) { fprintf(stderr, "Process %lu already has pages allocated\n", child); return; }
+	}
+
+	// Map every allocated page of the parent into the child
+	page_table_entry* parent_table = get_page_table_entry(pager, parent, 0);
+	for (uint64 p = 0; p < pager->num_pages; ++p)
+	{
+		page_table_entry* src_entry = &parent_table[p];
+		if (!(src_entry->flags & ALLOCATED)) { continue; }
+
+		// Shared pages stay shared, other writable pages become copy-on-write in both processes
+		if ((src_entry->flags & WRITE) && !(src_entry->flags & SHARED)) { src_entry->flags |= COPY_ON_WRITE; }
+		child_table[p].flags = (src_entry->flags & (READ | WRITE | EXECUTE | SHARED | COPY_ON_WRITE)) | ALLOCATED;
+		rmap_link(pager, child*pager->num_pages + p, parent*pager->num_pages + p);
+	}
 }
 
 // Helper function: Updates DIRTY and REFERENCE flags. Also increments the reference count.
 void update_flags_and_count(pager_data* pager, byte access, uint64 pid, uint64 page_number) {
 	pager->memory_reference_count++;
-	pager->page_tables[pid][page_number].flags |= REFERENCED | ((access & WRITE) ? DIRTY : 0);
+	get_page_table_entry(pager, pid, page_number)->flags |= REFERENCED | ((access & WRITE) ? DIRTY : 0);
 }
 
 // Helper function: processes incompatible privileges
@@ -131,7 +388,7 @@ int check_log_addr(pager_data* pager, uint64 pid, uint64 logical_addr, byte acce
 {	
 	// Get the page table entry
 	uint64 page_number = logical_addr >> pager->page_sz;
-	page_table_entry entry = pager->page_tables[pid][page_number];
+	page_table_entry entry = *get_page_table_entry(pager, pid, page_number);
 
 	// Check if page is allocated
 	if (!(entry.flags & ALLOCATED)) {
@@ -146,6 +403,17 @@ int check_log_addr(pager_data* pager, uint64 pid, uint64 logical_addr, byte acce
 		return INVALID_PAGE;
 	}
 
+	// Writing to a copy-on-write page gives the process its own copy of the page, which needs to
+	// be brought into a frame of its own
+	if ((access & WRITE) && (entry.flags & COPY_ON_WRITE)) {
+		printf("Process %lu wrote to copy-on-write page %lu so it gets a private copy\n", pid, page_number);
+		pager->pf_cow_copies++;
+		pager->cow_from_memory = (entry.flags & VALID) != 0;
+		rmap_unlink(pager, pid*pager->num_pages + page_number);
+		get_page_table_entry(pager, pid, page_number)->flags &= ~(VALID | REFERENCED | DIRTY | COPY_ON_WRITE);
+		entry.flags &= ~VALID;
+	}
+
 	// Check if not VALID (not memory resident)
 	if (!(entry.flags & VALID)) {
 		// If the page table entry is allocated, then increment both memory reference count and
@@ -161,13 +429,27 @@ int check_log_addr(pager_data* pager, uint64 pid, uint64 logical_addr, byte acce
 
 	// The memory reference count increases during page faults and therefore will always
 	// give a strict ordering to the frames for the LRU victim selection algorithm.
-	uint64 f = pager->page_tables[pid][page_number].frame; // Frame number
+	uint64 f = get_page_table_entry(pager, pid, page_number)->frame; // Frame number
 	pager->frames[f].LRU_value = pager->memory_reference_count;
 	return VALID_PAGE;
 }
 
+// Repeats a memory reference that was just checked by check_log_addr (and brought into memory if
+// needed) another n times. Since the page is known to be resident and the access to be allowed,
+// this only updates the reference count along with the flags and LRU value in bulk.
+void repeat_reference(pager_data* pager, uint64 pid, uint64 logical_addr, byte access, uint64 n)
+{
+	// Same as n hits from check_log_addr, the last one determines the LRU value
+	uint64 page_number = logical_addr >> pager->page_sz;
+	page_table_entry* entry = get_page_table_entry(pager, pid, page_number);
+	pager->memory_reference_count += n;
+	entry->flags |= REFERENCED | ((access & WRITE) ? DIRTY : 0);
+	pager->frames[entry->frame].LRU_value = pager->memory_reference_count;
+}
+
 // Have page page_number of process pid claim the frame f. If the frame is not free, then its contents are
-// evicted. This updates the frame and page table along with printing out status messages.
+// evicted, invalidating every mapping of them. This updates the frame and page table(s) along with
+// printing out status messages.
 void claim_frame(pager_data* pager, uint64 pid, uint64 logical_addr, uint64 f)
 {
 	// Get the page number and the frame being claimed.
@@ -179,9 +461,43 @@ void claim_frame(pager_data* pager, uint64 pid, uint64 logical_addr, uint64 f)
 		printf("Page %lu of process %lu ", claimed_frame->page_number, claimed_frame->pid);
 		printf("is selected to be paged out of frame %lu\n", f);
 		page_table_entry* evicted_page = get_page_from_frame(pager, f);
-		if (evicted_page->flags & DIRTY) {
+
+		// A shared page is modified if any of the processes mapping it wrote to it
+		uint64 evicted_idx = evicted_page - pager->page_tables, sharers = 0, flags = evicted_page->flags;
+		if (is_page_shared(pager, evicted_page))
+		{
+			for (uint64 i = pager->rmap_next[evicted_idx] - 1; i != evicted_idx; i = pager->rmap_next[i] - 1)
+			{
+				flags |= pager->page_tables[i].flags;
+				pager->page_tables[i].flags &= ~(VALID | REFERENCED | DIRTY);
+				sharers++;
+			}
+			printf("It is shared so %lu other mapping(s) of it are invalidated\n", sharers);
+		}
+		if (flags & DIRTY && pager->pool_sz) {
+			printf("It has been modified so it will be written to the compressed pool\n");
+			pager->pf_written_frames++;
+
+			// Replace any older copy in the pool with the new one at the end of the queue
+			uint64 old = pool_find(pager, evicted_idx);
+			if (old != EMPTY) { pool_remove(pager, old); }
+			pool_append(pager, evicted_idx);
+			set_tier(pager, evicted_idx, TIER_COMPRESSED);
+
+			// Write back the oldest page in the pool if it is now over its size
+			if (pager->pool_count > pager->pool_sz) {
+				uint64 oldest = pager->pool_head;
+				printf("Page %lu of process %lu is written back from the compressed pool to the swap space\n",
+				       oldest % pager->num_pages, oldest / pager->num_pages);
+				pool_remove(pager, oldest);
+				set_tier(pager, oldest, TIER_SWAP);
+				pager->pool_written_back++;
+			}
+		}
+		else if (flags & DIRTY) {
 			printf("It has been modified so it will be written to the swap space\n");
 			pager->pf_written_frames++;
+			set_tier(pager, evicted_idx, TIER_SWAP);
 		}
 		else {
 			printf("It has not been modified so it will be discarded\n");
@@ -200,8 +516,46 @@ void claim_frame(pager_data* pager, uint64 pid, uint64 logical_addr, uint64 f)
 	claimed_frame->pid = pid;
 	claimed_frame->page_number = page_number;
 	pager->frames[f].LRU_value = pager->memory_reference_count;
-	pager->page_tables[pid][page_number].frame = f;
-	get_page_from_frame(pager, f)->flags |= VALID;
+	page_table_entry* entry = get_page_table_entry(pager, pid, page_number);
+	entry->frame = f;
+	entry->flags |= VALID;
+
+	// A copy-on-write copy of a page that is still in memory is made from that frame, otherwise
+	// the page comes from whichever tier holds it
+	if (pager->cow_from_memory) { pager->pf_cow_from_memory++; pager->cow_from_memory = false; }
+	else { pager->pf_tier[entry->tier]++; }
+
+	// Every other process mapping the page now sees it in the frame as well
+	if (is_page_shared(pager, entry))
+	{
+		uint64 idx = entry - pager->page_tables;
+		for (uint64 i = pager->rmap_next[idx] - 1; i != idx; i = pager->rmap_next[i] - 1)
+		{
+			pager->page_tables[i].frame = f;
+			pager->page_tables[i].flags |= VALID;
+		}
+	}
+}
+
+// Checks if the page resident in frame f has been referenced by any of the processes mapping it,
+// clearing the REFERENCED flag of all of those mappings.
+bool frame_test_and_clear_referenced(pager_data* pager, uint64 f)
+{
+	page_table_entry* page = get_page_from_frame(pager, f);
+	bool referenced = page->flags & REFERENCED;
+	page->flags &= ~REFERENCED;
+
+	// Check the other mappings of a shared page as well
+	if (is_page_shared(pager, page))
+	{
+		uint64 idx = page - pager->page_tables;
+		for (uint64 i = pager->rmap_next[idx] - 1; i != idx; i = pager->rmap_next[i] - 1)
+		{
+			referenced |= (pager->page_tables[i].flags & REFERENCED) != 0;
+			pager->page_tables[i].flags &= ~REFERENCED;
+		}
+	}
+	return referenced;
 }
 
 // Prints out the summary information for the simulation run including a divider.
@@ -212,4 +566,21 @@ void print_summary(pager_data* pager)
 	printf("Total Page Faults: %lu\n", pager->pf_total);
 	printf("Total Page Faults Evicting and Discarding a Frame: %lu\n", pager->pf_discarded_frames);
 	printf("Total Page Faults Evicting and Writing a Frame: %lu\n", pager->pf_written_frames);
+	if (pager->pf_cow_copies) { printf("Total Copy-on-Write Faults: %lu\n", pager->pf_cow_copies); }
+
+	// Tier statistics are only printed if there is a compressed pool
+	if (pager->pool_sz)
+	{
+		uint64 dram_hits = pager->memory_reference_count - pager->pf_total;
+		uint64 latency = (dram_hits + pager->pf_cow_from_memory)*pager->dram_latency;
+		for (int t = TIER_NONE; t <= TIER_SWAP; ++t) { latency += pager->pf_tier[t]*pager->tier_latency[t]; }
+		printf("Total References Served from Memory: %lu\n", dram_hits);
+		printf("Total Copy-on-Write Faults Served from Memory: %lu\n", pager->pf_cow_from_memory);
+		printf("Total Page Faults Served from the Compressed Pool: %lu\n", pager->pf_tier[TIER_COMPRESSED]);
+		printf("Total Page Faults Served from the Swap Space: %lu\n", pager->pf_tier[TIER_SWAP]);
+		printf("Total Page Faults Served from the Backing Store: %lu\n", pager->pf_tier[TIER_NONE]);
+		printf("Total Pages Written Back from the Compressed Pool: %lu\n", pager->pool_written_back);
+		printf("Modelled Memory Latency: %lu ns (%f ns per reference)\n", latency,
+		       (double) latency / pager->memory_reference_count);
+	}
 }
@@ -19,6 +19,8 @@
 #define DIRTY   	0x10
 #define VALID   	0x20
 #define REFERENCED  0x40
+#define SHARED      0x80  // page is explicitly shared with other processes (s directive)
+#define COPY_ON_WRITE 0x100 // page is shared after a fork and must be copied before it is written
 
 // Constants returned by check_log_addr
 #define INVALID_PAGE -1
@@ -28,8 +30,22 @@
 // Constant for empty head/next_frame
 #define EMPTY (uint64) -1
 
-// Each frame needs to know which process/page is currently resident in it
-// next_frame is the frame after the current frame in the FIFO queue
+// Tiers that hold the copy of a page that is outside of memory (stored in the tier bits of the page
+// table entry). A page that is in no tier has never been written out and is read from its backing
+// store (e.g. its file) if needed. The copy stays in its tier after the page is brought back into
+// memory until the page is modified and written out again.
+#define TIER_NONE       0
+#define TIER_COMPRESSED 1
+#define TIER_SWAP       2
+
+// Default modelled latency (in nanoseconds) of a memory reference served from memory, from the
+// compressed pool, and from the swap space or backing store (see set_tier_latencies)
+#define DEFAULT_DRAM_LATENCY       100
+#define DEFAULT_COMPRESSED_LATENCY 2000
+#define DEFAULT_SWAP_LATENCY       100000
+
+// Each frame needs to know which process/page is currently resident in it. When the page is mapped
+// by several processes this is just one of the mappings, the rest are found with the reverse-map.
 typedef struct _frame
 {
 	bool occupied; // false if free, true otherwise
@@ -45,7 +61,8 @@ typedef struct _page_table_entry
 {
 	uint64 flags  : 12; // Lowest 12 bits are for flags
 	uint64 frame  : 40; // The next 40 bits are for the frame
-	uint64 unused : 12; // Last 12 bits are unused for now, you may use them for use with the paging algorithm(s)
+	uint64 tier   : 2;  // The next 2 bits are the tier holding the copy of the page outside of memory
+	uint64 unused : 10; // Last 10 bits are unused for now, you may use them for use with the paging algorithm(s)
 } page_table_entry;
 
 // Structure for common fields used by all pagers
@@ -59,11 +76,37 @@ typedef struct _pager_data
 	uint64 num_free_frames;
 	frame* frames; // array to lookup pid/page number resident in each frame
 
-	// The page tables, a 2D array of pages indexed by process number then by the page number.
-	page_table_entry** page_tables;
+	// The page tables, a single flat array of pages indexed by process number times num_pages plus
+	// the page number. Use get_page_table_entry() instead of indexing it directly.
+	page_table_entry* page_tables;
+
+	// Reverse-map: every page table entry that is mapped by more than one process is on a circular
+	// doubly-linked list with all other entries mapping the same page. These are indexed the same
+	// as page_tables and hold the index+1 of the next/previous entry, or 0 if the page is private.
+	uint64 *rmap_next, *rmap_prev;
+
+	// Compressed pool: a FIFO queue of the pages that have a copy in the pool (one entry per page even
+	// if it is shared). The links are indexed the same as page_tables and hold the index+1 of the
+	// next/previous entry in the queue, or 0 if there is none. The head is the oldest entry which is
+	// written back to the swap space when the pool is over its size (in pages, 0 if there is no pool).
+	// If there is no pool then the links are not allocated at all and are NULL.
+	uint64 *pool_next, *pool_prev;
+	uint64 pool_head, pool_tail, pool_count, pool_sz;
 
 	// Page fault statistics
-	uint64 memory_reference_count, pf_total, pf_discarded_frames, pf_written_frames;
+	uint64 memory_reference_count, pf_total, pf_discarded_frames, pf_written_frames, pf_cow_copies;
+
+	// Tier statistics: page faults served by each tier, copy-on-write faults whose source page was
+	// already in memory (so the copy is served from memory), and pages written back from the
+	// compressed pool to the swap space. References served from memory are the references that
+	// did not fault. cow_from_memory is set by check_log_addr for the fault claim_frame handles next.
+	uint64 pf_tier[3], pf_cow_from_memory, pool_written_back;
+	bool cow_from_memory;
+
+	// Modelled latency (in nanoseconds) of a memory reference served from memory and of a page fault
+	// served by each tier (indexed by tier, a page in no tier is read from the backing store which
+	// is modelled the same as the swap space)
+	uint64 dram_latency, tier_latency[3];
 
 	// Next victim of FIFO queue
 	uint64 FIFO_victim;
@@ -72,19 +115,42 @@ typedef struct _pager_data
 	// We can get the page from the frame.
 	uint64 SC_head_frame;
 
+	// The pager, the frames, the page tables, the reverse-map links, and the compressed pool links (if
+	// there is a pool) all live in one arena. This is its total size and whether it came from mmap
+	// (large configurations) or calloc (small ones).
+	uint64 arena_sz;
+	bool arena_mapped;
+
 } pager_data;
 
+// Utility function to get the page table entry for page p of process pid
+static inline page_table_entry* get_page_table_entry(pager_data* pager, uint64 pid, uint64 p)
+{
+	return &pager->page_tables[pid*pager->num_pages + p];
+}
+
+// Utility function to check if a page table entry is mapped by more than one process
+static inline bool is_page_shared(pager_data* pager, page_table_entry* entry)
+{
+	return pager->rmap_next[entry - pager->page_tables] != 0;
+}
+
 // Utility function to get the page currently resident in a frame
 static inline page_table_entry* get_page_from_frame(pager_data* pager, uint64 f)
 {
 	frame* frm = &pager->frames[f];
-	return &pager->page_tables[frm->pid][frm->page_number];
+	return get_page_table_entry(pager, frm->pid, frm->page_number);
 }
 
 // Initialize the pager with the given logical memory size (in number of pages), the physical
 // memory size (in number of frames), the size of an individual page/frame (in bits), and the
-// maximum number of processes on the system.
-pager_data* pager_data_init(uint64 log_mem_sz, uint64 phy_mem_sz, uint64 page_sz, uint64 num_procs);
+// maximum number of processes on the system, and the size of the compressed pool (in number of
+// pages, 0 to write modified pages directly to the swap space).
+pager_data* pager_data_init(uint64 log_mem_sz, uint64 phy_mem_sz, uint64 page_sz, uint64 num_procs, uint64 pool_sz);
+
+// Set the modelled latency (in nanoseconds) of a memory reference served from memory, from the
+// compressed pool, and from the swap space or backing store. These are only used for the summary.
+void set_tier_latencies(pager_data* pager, uint64 dram, uint64 compressed, uint64 swap);
 
 // Deallocate any memory that was allocated for the pager (including the pager itself). After
 // this is called the pager can no longer be used.
@@ -98,17 +164,43 @@ void pager_data_dealloc(pager_data* pager);
 // anything out.
 void alloc_page(pager_data* pager, uint64 pid, uint64 p, byte access);
 
+// A request for process pid to map page p of process src_pid at the same page number is being made.
+// Both processes see the same page from then on: it is paged in and out for all of them at once and
+// writes from either process are visible to the other. The page of pid must not be allocated yet
+// and the page of src_pid must not be mapped by a fork (those are copy-on-write, not shared). This
+// function does not bring a page into memory and does not print anything out.
+void share_page(pager_data* pager, uint64 pid, uint64 p, uint64 src_pid);
+
+// A request for process parent to fork into process child is being made. Every page allocated for
+// the parent is mapped into the child. Writable pages are marked copy-on-write in both processes
+// so the first write from either side gets a private copy. The child must not have any pages
+// allocated yet. This function does not bring a page into memory and does not print anything out.
+void fork_process(pager_data* pager, uint64 parent, uint64 child);
+
 // This checks that the referenced page is a valid page for the given pocess and access request.
 //
 // If it is not valid then a descriptive message is printed out and INVALID_PAGE is returned.
 // If it is valid then it updates the REFERENCED and possibly the DIRTY flag of the page. If memory
-// resident then VALID_PAGE is returned, otherwise PAGE_FAULT is returned.
+// resident then VALID_PAGE is returned, otherwise PAGE_FAULT is returned. Writing to a copy-on-write
+// page first gives the process a private copy of the page, which always results in PAGE_FAULT.
 int check_log_addr(pager_data* pager, uint64 pid, uint64 logical_addr, byte access);
 
+// Repeats a memory reference that was just checked by check_log_addr (and brought into memory if
+// needed) another n times. Since the page is known to be resident and the access to be allowed,
+// this only updates the reference count along with the flags and LRU value in bulk.
+void repeat_reference(pager_data* pager, uint64 pid, uint64 logical_addr, byte access, uint64 n);
+
 // Have page p of process pid claim the frame f. If the frame is not free than its contents are
-// evicted. This updates the frame and page table along with printing out status messages.
+// evicted, invalidating every mapping of them. Modified contents are written to the compressed pool
+// if there is one (writing back the oldest page in the pool to the swap space if it is full) and to
+// the swap space otherwise. This updates the frame and page table(s) along with printing out status
+// messages.
 void claim_frame(pager_data* pager, uint64 pid, uint64 logical_addr, uint64 f);
 
+// Checks if the page resident in frame f has been referenced by any of the processes mapping it,
+// clearing the REFERENCED flag of all of those mappings.
+bool frame_test_and_clear_referenced(pager_data* pager, uint64 f);
+
 // Prints out the summary information for the simulation run including a divider.
 void print_summary(pager_data* pager);
 
@@ -16,13 +16,10 @@ uint64 sc_select_victim_frame(pager_data* pager)
 	if (pager->num_free_frames > 0) { return pager->num_frames - pager->num_free_frames; }
 
 	// Loop through the pages in the frames and select the first frame whose page has a 
-	// REFERENCED bit of 0.
+	// REFERENCED bit of 0 (in all of the processes mapping it).
 	uint64 frame_number = pager->SC_head_frame;
-	page_table_entry* page = get_page_from_frame(pager, frame_number);
-	while (page->flags & REFERENCED) {
-		page->flags ^= REFERENCED; // Set bit to 0
+	while (frame_test_and_clear_referenced(pager, frame_number)) { // Sets bit(s) to 0
 		frame_number = (frame_number + 1) % pager->num_frames;
-		page = get_page_from_frame(pager, frame_number);
 	}
 	pager->SC_head_frame = (frame_number + 1) % pager->num_frames;
 	return frame_number;